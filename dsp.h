@@ -23,6 +23,7 @@
 
 #include "JACK/Client.H"
 #include <math.h>
+#include <atomic>
 
 
 sample_t *buffer_alloc ( nframes_t size );
@@ -37,6 +38,13 @@ void buffer_interleave_one_channel_and_mix ( sample_t *dst, const sample_t *src,
 void buffer_deinterleave_one_channel ( sample_t *dst, const sample_t *src, int channel, int channels, nframes_t nframes );
 void buffer_interleaved_mix ( sample_t *__restrict__ dst, const sample_t * __restrict__ src, int dst_channel, int src_channel, int dst_channels, int src_channels, nframes_t nframes );
 void buffer_interleaved_copy ( sample_t *__restrict__ dst, const sample_t * __restrict__ src, int dst_channel, int src_channel, int dst_channels, int src_channels, nframes_t nframes );
+/* all channels at once, between an interleaved buffer and one buffer
+ * per channel. A NULL channel buffer is treated as silence on
+ * interleave, and skipped on deinterleave */
+void buffer_interleave ( sample_t *dst, const sample_t * const *src, int channels, nframes_t nframes );
+void buffer_interleave_and_mix ( sample_t *dst, const sample_t * const *src, int channels, nframes_t nframes );
+void buffer_deinterleave ( sample_t * const *dst, const sample_t *src, int channels, nframes_t nframes );
+void buffer_deinterleave_and_mix ( sample_t * const *dst, const sample_t *src, int channels, nframes_t nframes );
 void buffer_fill_with_silence ( sample_t *buf, nframes_t nframes );
 bool buffer_is_digital_black ( const sample_t *buf, nframes_t nframes );
 float buffer_get_peak ( const sample_t *buf, nframes_t nframes );
@@ -69,6 +77,200 @@ public:
 
 };
 
+/* A delay of a variable number of frames, for latency compensation.
+ * The ring buffer is allocated by reserve() outside of the process
+ * thread and picked up by process() without locking, so both the delay
+ * and the storage behind it may change while audio is running. */
+class Delay_Line
+{
+    struct Ring
+    {
+        sample_t *data;
+        nframes_t mask;
+        /* a period of output, for process() without a destination */
+        sample_t *out;
+        nframes_t period;
+    };
+
+    Ring *_ring;
+    nframes_t _write;
+
+    std::atomic<Ring*> _pending;
+    std::atomic<Ring*> _retired;
+    std::atomic<nframes_t> _delay;
+
+    nframes_t _capacity;
+    nframes_t _period;
+
+    static void free_ring ( Ring *r );
+    void take_pending ( void );
+
+    /* not permitted */
+    Delay_Line ( const Delay_Line &rhs );
+    Delay_Line & operator = ( const Delay_Line &rhs );
+
+public:
+
+    Delay_Line ( );
+    ~Delay_Line ( );
+
+    /* make room for a delay of /frames/ with periods of /nframes/ */
+    void reserve ( nframes_t frames, nframes_t nframes );
+    nframes_t capacity ( void ) const { return _capacity; }
+
+    void delay ( nframes_t frames ) { _delay.store( frames, std::memory_order_relaxed ); }
+    nframes_t delay ( void ) const { return _delay.load( std::memory_order_relaxed ); }
+
+    /* THREAD: RT */
+    void process ( const sample_t *src, sample_t *dst, nframes_t nframes );
+    /* THREAD: RT */
+    void process ( sample_t *buf, nframes_t nframes ) { process( buf, buf, nframes ); }
+    /* THREAD: RT */
+    /* delay into a buffer owned by the line, valid until the next call.
+     * Returns NULL if nothing has been reserved for periods this long */
+    sample_t * process_copy ( const sample_t *src, nframes_t nframes );
+};
+
+/* Block resampler using cubic interpolation, for any number of
+ * channels, planar or interleaved. The last input frames of each call
+ * are kept, so a stream can be fed in periods of any size. The ratio
+ * (output rate / input rate) may be fixed, or ramped across a call for
+ * varispeed. Nothing is allocated after construction. */
+class Resampler
+{
+    int _channels;
+
+    /* input frames per output frame */
+    double _step;
+    /* position of the next output frame, counting from the oldest frame of history */
+    double _pos;
+
+    /* the last three input frames of each channel */
+    sample_t *_history;
+
+    nframes_t plan ( nframes_t *index, float *frac, nframes_t nframes, nframes_t in, double dstep );
+    void consume ( const sample_t * const *src, const sample_t *interleaved, nframes_t in, nframes_t *used );
+
+    /* not permitted */
+    Resampler ( const Resampler &rhs );
+    Resampler & operator = ( const Resampler &rhs );
+
+public:
+
+    explicit Resampler ( int channels );
+    ~Resampler ( );
+
+    int channels ( void ) const { return _channels; }
+
+    void ratio ( double r ) { _step = 1.0 / r; }
+    double ratio ( void ) const { return 1.0 / _step; }
+
+    /* forget the history, as after a locate */
+    void reset ( void );
+
+    /* the input frames needed for the next call to produce /out/ frames at the current ratio */
+    nframes_t input_frames ( nframes_t out ) const;
+
+    /* Produce up to /out/ frames into /dst/ from the /in/ frames of
+     * /src/, returning the number produced. /used/ is set to the
+     * number of input frames consumed, the rest must be passed again
+     * next time. With /ratio/ the ratio moves from its current value
+     * to /ratio/ over the /out/ frames */
+    nframes_t process ( sample_t * const *dst, nframes_t out, const sample_t * const *src, nframes_t in, nframes_t *used );
+    nframes_t process ( sample_t * const *dst, nframes_t out, const sample_t * const *src, nframes_t in, nframes_t *used, double ratio );
+    nframes_t process_interleaved ( sample_t *dst, nframes_t out, const sample_t *src, nframes_t in, nframes_t *used );
+    nframes_t process_interleaved ( sample_t *dst, nframes_t out, const sample_t *src, nframes_t in, nframes_t *used, double ratio );
+
+private:
+
+    nframes_t run ( sample_t * const *dst, sample_t *interleaved_dst, nframes_t out, const sample_t * const *src, const sample_t *interleaved_src, nframes_t in, nframes_t *used, double dstep );
+};
+
+/* Peak, RMS and true peak (4x oversampled) meters for any number of
+ * channels, with falloff and peak hold. process() is called from the
+ * process thread once per period, and any number of other threads may
+ * read() the latest values at any time without taking a lock. All
+ * levels are linear. The true peak is found by cubic interpolation,
+ * which reads up to a couple of dB low for content near Nyquist. */
+class Meter
+{
+public:
+
+    struct Reading
+    {
+        /* sample peak, falling off */
+        float peak;
+        /* highest recent peak, held for hold_time() */
+        float hold;
+        /* RMS over the window */
+        float rms;
+        /* inter-sample peak, falling off */
+        float true_peak;
+    };
+
+private:
+
+    struct Channel
+    {
+        float peak;
+        float hold;
+        nframes_t hold_left;
+        float ms;
+        float true_peak;
+        /* the last three samples, for interpolating across periods */
+        sample_t history[3];
+    };
+
+    int _channels;
+    Channel *_state;
+
+    /* four values per channel, guarded by _sequence, which is odd
+     * while they are being written */
+    std::atomic<float> *_published;
+    std::atomic<unsigned int> _sequence;
+
+    std::atomic<bool> _reset;
+
+    std::atomic<nframes_t> _sample_rate;
+    std::atomic<float> _falloff;
+    std::atomic<float> _hold_time;
+    std::atomic<float> _window;
+
+    void clear ( void );
+
+    /* not permitted */
+    Meter ( const Meter &rhs );
+    Meter & operator = ( const Meter &rhs );
+
+public:
+
+    Meter ( int channels, nframes_t sample_rate );
+    ~Meter ( );
+
+    int channels ( void ) const { return _channels; }
+
+    void sample_rate ( nframes_t v ) { _sample_rate = v; }
+    /* in dB per second */
+    void falloff ( float v ) { _falloff = v; }
+    float falloff ( void ) const { return _falloff; }
+    /* in seconds */
+    void hold_time ( float v ) { _hold_time = v; }
+    float hold_time ( void ) const { return _hold_time; }
+    void rms_window ( float v ) { _window = v; }
+    float rms_window ( void ) const { return _window; }
+
+    /* clear all levels at the start of the next period */
+    void reset ( void ) { _reset = true; }
+
+    /* THREAD: RT */
+    /* a NULL buffer is treated as silence */
+    void process ( const sample_t * const *buffers, nframes_t nframes );
+
+    /* the latest values of every channel, into channels() readings */
+    void read ( Reading *readings ) const;
+    Reading read ( int channel ) const;
+};
+
 static inline float interpolate_cubic ( const float fr, const float inm1, const float in, const float inp1, const float inp2)
 {
     return in + 0.5f * fr * (inp1 - inm1 +
@@ -19,5 +19,16 @@
 /* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
 /*******************************************************************************/
 
+#pragma once
+
+#include <stddef.h>
+
 void unescape_url ( char *url );
 char * escape_url ( const char *url );
+/* escape /url/ into /buf/, which is /size/ bytes long, returning the
+ * length of the whole escaped string as snprintf() does */
+size_t escape_url ( const char *url, char *buf, size_t size );
+
+/* the offset of the first /a/ or /b/ in the /n/ bytes at /s/, or /n/ if
+ * there is neither. Looks at a word at a time */
+size_t find_either ( const char *s, size_t n, char a, char b );